@@ -0,0 +1,175 @@
+#ifndef DFA_PROFILER_H
+#define DFA_PROFILER_H 1
+
+#include "finite_automata.h"
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+
+namespace alegna::lexer::automata
+{
+    //A class that records how often each state and each transition of a
+    //deterministic finite automatum (DFA) is used while reading a training
+    //corpus. The counts are used to renumber the states of the DFA so that
+    //frequently used states are next to each other in the transition table.
+    //@param _TokTp the type of tokens used in the automatum.
+    template<typename _TokTp>
+    class dfa_profiler
+    {
+        public:
+            //Creates a new dfa_profiler for the specified DFA. The DFA
+            //must outlive the profiler.
+            //
+            //@param dfa the DFA to be profiled
+            explicit dfa_profiler(const automatum<_TokTp>& dfa)
+                : _M_dfa(dfa), _M_state_hits(dfa.get_table().size(), 0),
+                  _M_transition_hits(dfa.get_table().size())
+            {
+
+            }
+
+            //Runs the DFA over a training corpus and adds to the hit counts.
+            //Like the lexer, starts over from state 0 whenever the DFA reaches
+            //the error state.
+            //
+            //@param first the beginning of the corpus
+            //@param last the end of the corpus
+            template<typename _InputIt>
+            void profile(_InputIt first, _InputIt last)
+            {
+                state_t curr_state = 0;
+                while (first != last)
+                {
+                    ++_M_state_hits[curr_state];
+                    state_t next_state = _M_dfa.delta(curr_state, *first);
+                    if (next_state == automatum<_TokTp>::ERROR)
+                    {
+                        //Retry the token from the start state unless the
+                        //DFA is already there
+                        if (curr_state == 0)
+                            ++first;
+                        curr_state = 0;
+                        continue;
+                    }
+                    ++_M_transition_hits[curr_state][next_state];
+                    curr_state = next_state;
+                    ++first;
+                }
+            }
+
+            //Returns the number of times a state was visited.
+            //@param s the state
+            //@return the number of times s was visited
+            std::size_t state_hits(state_t s) const
+            {
+                return _M_state_hits[s];
+            }
+
+            //Returns the number of times the DFA moved from one state to another.
+            //@param from the state the DFA moved from
+            //@param to the state the DFA moved to
+            //@return the number of transitions from from to to
+            std::size_t transition_hits(state_t from, state_t to) const
+            {
+                const auto& row = _M_transition_hits[from];
+                auto it = row.find(to);
+                return it == row.end() ? 0 : it->second;
+            }
+
+            //Computes a new numbering for the states of the DFA. State 0 stays
+            //first. Each following state is the most frequent successor of the
+            //previously placed state, or the most visited remaining state if the
+            //previous state has no unplaced successor. Hot states and their
+            //common successors therefore end up next to each other.
+            //
+            //@return a vector mapping the old number of each state to its new number
+            std::vector<state_t> hot_order() const
+            {
+                const std::size_t num_states = _M_state_hits.size();
+                std::vector<state_t> new_numbers(num_states, automatum<_TokTp>::ERROR);
+                if (num_states == 0)
+                    return new_numbers;
+
+                //Remaining states from most to least visited
+                std::vector<state_t> by_hits(num_states);
+                for (std::size_t i = 0; i < num_states; ++i)
+                    by_hits[i] = static_cast<state_t>(i);
+                std::stable_sort(by_hits.begin(), by_hits.end(), [this](state_t lhs, state_t rhs) {
+                    return _M_state_hits[lhs] > _M_state_hits[rhs];
+                });
+                auto next_hottest = by_hits.begin();
+
+                state_t placed = 0;
+                state_t last = 0;
+                new_numbers[0] = placed++;
+                while (static_cast<std::size_t>(placed) < num_states)
+                {
+                    //Hottest successor of the last placed state
+                    state_t next = automatum<_TokTp>::ERROR;
+                    std::size_t next_hits = 0;
+                    for (const auto& transition: _M_transition_hits[last])
+                    {
+                        bool better = transition.second > next_hits ||
+                                      (transition.second == next_hits && transition.first < next);
+                        if (new_numbers[transition.first] == automatum<_TokTp>::ERROR && better)
+                        {
+                            next = transition.first;
+                            next_hits = transition.second;
+                        }
+                    }
+                    if (next == automatum<_TokTp>::ERROR)
+                    {
+                        while (new_numbers[*next_hottest] != automatum<_TokTp>::ERROR)
+                            ++next_hottest;
+                        next = *next_hottest;
+                    }
+                    new_numbers[next] = placed++;
+                    last = next;
+                }
+                return new_numbers;
+            }
+
+        private:
+            //The DFA being profiled
+            const automatum<_TokTp>& _M_dfa;
+            //Number of times each state was visited
+            std::vector<std::size_t> _M_state_hits;
+            //Number of times each transition was taken, indexed by source state
+            std::vector<std::unordered_map<state_t, std::size_t>> _M_transition_hits;
+    };
+
+    //Creates a copy of an automatum with its states renumbered.
+    //
+    //@param fa the automatum whose states will be renumbered
+    //@param new_numbers a vector mapping the old number of each state to its
+    //                   new number, such as the one returned by
+    //                   dfa_profiler::hot_order
+    //@return an equivalent automatum with renumbered states, packed if 
+    //        fa was packed
+    template<typename _TokTp>
+    automatum<_TokTp> renumber_states(const automatum<_TokTp>& fa, const std::vector<state_t>& new_numbers)
+    {
+        const auto& table = fa.get_table();
+        typename automatum<_TokTp>::fa_table_t new_table(table.size());
+        for (std::size_t s = 0; s < table.size(); ++s)
+        {
+            auto& row = new_table[new_numbers[s]];
+            for (const auto& transition: table[s])
+            {
+                state_t target = transition.second;
+                if (target != automatum<_TokTp>::ERROR)
+                    target = new_numbers[target];
+                row.emplace(transition.first, target);
+            }
+        }
+        std::unordered_set<state_t> new_accepting_states;
+        for (const auto s: fa.get_accepting_states())
+            new_accepting_states.insert(new_numbers[s]);
+        automatum<_TokTp> renumbered(new_table, new_accepting_states);
+        if (fa.is_packed())
+            renumbered.pack();
+        return renumbered;
+    }
+}
+
+#endif
@@ -2,19 +2,119 @@
 #define FINITE_AUTOMATA_H
 
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <type_traits>
 #include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
+#include <map>
 
 namespace alegna::lexer::automata
 {
     //A type to represent a finite automatum state.
-    typedef short state_t;
+    typedef std::int32_t state_t;
+
+    //A transition table over bytes, packed so that a lookup takes a 
+    //few loads. Dense tables are stored as a full table with one row 
+    //of 256 entries per state. Sparse tables, typical of DFAs with 
+    //thousands of states, are stored as a comb vector: every state has 
+    //a default transition, and its other transitions are stored in 
+    //next at base[state] + byte, valid only if check at that index is 
+    //the state. Rows are overlapped so their transitions fill each 
+    //other's gaps, in state order so that states with close numbers 
+    //stay close in memory.
+    class packed_table
+    {
+        public:
+            //How the table is stored.
+            enum class layout 
+            {
+                eDense,
+                eComb
+            };
+
+            //Tables where more than this fraction of transitions differ 
+            //from their state's default transition are stored dense.
+            static constexpr double DENSE_THRESHOLD = 0.25;
+
+            //Creates an empty table.
+            packed_table() = default;
+
+            //Packs a transition table, choosing the layout from the 
+            //table's density. Missing transitions go to the error state.
+            //
+            //@param rows the transitions of every state
+            explicit packed_table(const std::vector<std::unordered_map<char, state_t>>& rows);
+
+            //Finds the next state from state s on byte c. s must be a 
+            //state of the table.
+            //@param s the current state
+            //@param c the byte just read
+            //@return the next state 
+            state_t delta(state_t s, char c) const
+            {
+                const std::size_t b = static_cast<unsigned char>(c);
+                if (_M_layout == layout::eDense)
+                    return _M_next[(static_cast<std::size_t>(s) << 8) | b];
+                const std::size_t i = _M_base[s] + b;
+                return _M_check[i] == s ? _M_next[i] : _M_default[s];
+            }
+
+            //Returns the index in the table's next state array of the 
+            //entry for byte 0 of a state's row. States whose rows have 
+            //close offsets share cache lines.
+            //@param s a state of the table
+            //@return the offset of s's row
+            std::size_t row_offset(state_t s) const
+            {
+                if (_M_layout == layout::eDense)
+                    return static_cast<std::size_t>(s) << 8;
+                return _M_base[s];
+            }
+
+            //Returns the layout of the table.
+            layout get_layout() const
+            {
+                return _M_layout;
+            }
+
+            //Returns true if the table has not been packed.
+            bool empty() const
+            {
+                return _M_next.empty();
+            }
+
+            //Returns the number of bytes used by the table's arrays.
+            std::size_t size_bytes() const
+            {
+                return sizeof(state_t) * (_M_base.size() + _M_next.size() + _M_check.size() + _M_default.size());
+            }
+
+        private:
+            //Stores every transition, one row of 256 entries per state.
+            void pack_dense(const std::vector<std::unordered_map<char, state_t>>& rows);
+
+            //Stores the transitions of every state that differ from its 
+            //default transition in an overlapped comb vector.
+            void pack_comb(const std::vector<std::unordered_map<char, state_t>>& rows);
+
+        private:
+            layout _M_layout = layout::eDense;
+            //Offset of each state's transitions in _M_next (comb only)
+            std::vector<state_t> _M_base;
+            //Next states
+            std::vector<state_t> _M_next;
+            //Owner of each entry in _M_next (comb only)
+            std::vector<state_t> _M_check;
+            //Default transition of each state (comb only)
+            std::vector<state_t> _M_default;
+    };
 
     //A struct that represents a finite automatum (FA). Contains information 
     //about the FA's state transition function (represented as a table) and the 
-    //accepting states of the FA. Can represent a non-deterministic FA or a 
-    //deterministic FA.
+    //accepting states of the FA. Each state has at most one transition per 
+    //token, so non-deterministic FAs are represented by nfa_automatum.
     //@param _TokTp the type of tokens used in the automatum. 
     template<typename _TokTp>
     struct automatum
@@ -25,20 +125,36 @@ namespace alegna::lexer::automata
         typedef std::vector<std::unordered_map<_TokTp, state_t>> fa_table_t;
 
         //The error state 
-        static const state_t ERROR = -1;
+        static constexpr state_t ERROR = -1;
         //Epsilon transition 
-        static const char EPSILON = '/0';
+        static constexpr char EPSILON = '\0';
 
         //Constructs a new finite automatum with the specified state transition table and 
         //set of accepting states. 
         //@param transitions the state transition table for the automatum 
         //@param accepting_states the set of accepting states
-        automatum(const std::vector<state_t>& states, const fa_table_t& transitions, const std::unordered_set<state_t>& accepting_states)
-             : _M_states(states), _M_transitions(transitions), _M_accepting_states(_accepting_states)
+        automatum(const fa_table_t& transitions, const std::unordered_set<state_t>& accepting_states)
+             : _M_transitions(transitions), _M_accepting(accepting_states)
         {
 
         }
 
+        //Packs the state transition table so that delta takes a few 
+        //loads instead of a hash lookup. Costs O(states * 256), so it 
+        //should only be called on finished DFAs, not on NFA fragments. 
+        //Only automata over bytes are packed, does nothing otherwise.
+        void pack()
+        {
+            if constexpr (std::is_same_v<_TokTp, char>)
+                _M_packed = packed_table(_M_transitions);
+        }
+
+        //Returns true if the state transition table has been packed.
+        bool is_packed() const
+        {
+            return !_M_packed.empty();
+        }
+
         //Finds the next state based on the current state and the 
         //token just read. If no valid transition exists, 
         //returns the error state.
@@ -46,9 +162,14 @@ namespace alegna::lexer::automata
         //@param tok the token just read.
         state_t delta(state_t s, const _TokTp& tok) const
         {
-            if (s >= _M_transitions.size())
+            if (s < 0 || static_cast<std::size_t>(s) >= _M_transitions.size())
                 return ERROR;
-            auto row = _M_transitions(row);
+            if constexpr (std::is_same_v<_TokTp, char>)
+            {
+                if (!_M_packed.empty())
+                    return _M_packed.delta(s, tok);
+            }
+            const auto& row = _M_transitions[s];
             auto it = row.find(tok);
             if (it != row.end())
                 return it->second;
@@ -64,21 +185,118 @@ namespace alegna::lexer::automata
             return _M_accepting.find(s) != _M_accepting.end();
         }
 
-        const std::vector<std::unordered_map<_TokTp, state_t*>>& get_table() const
+        const fa_table_t& get_table() const
         {
             return _M_transitions;
         }
 
-        const std::unordered_set<state_t*>& get_accepting_states() const
+        const std::unordered_set<state_t>& get_accepting_states() const
         {
             return _M_accepting;
         }
 
+        //Returns the packed form of the transition table used by delta. 
+        //Empty until pack is called.
+        const packed_table& get_packed_table() const
+        {
+            return _M_packed;
+        }
+
         private:
             //The state transition table of the automatum
             std::vector<std::unordered_map<_TokTp, state_t>> _M_transitions;
             //The accepting states of the automatum
            std::unordered_set<state_t> _M_accepting;
+            //The state transition table packed for fast lookups
+            packed_table _M_packed;
+    };
+
+    //A struct that represents a non-deterministic finite automatum (NFA), 
+    //such as the output of Thompson's construction. A state can have any 
+    //number of transitions on the same token and any number of epsilon 
+    //transitions. Epsilon transitions are stored apart from the token 
+    //transitions, so every token value, including '\0', is a real token.
+    //@param _TokTp the type of tokens used in the automatum. 
+    template<typename _TokTp>
+    struct nfa_automatum
+    {
+        //A type representing the type of tokens used in the automatum.
+        typedef _TokTp token_type;
+        //Convenience type to represent the token transitions of the NFA
+        typedef std::vector<std::unordered_map<_TokTp, std::vector<state_t>>> nfa_table_t;
+        //Convenience type to represent the epsilon transitions of the NFA
+        typedef std::vector<std::vector<state_t>> epsilon_table_t;
+
+        //Constructs a new NFA with the specified transitions and set of 
+        //accepting states. 
+        //@param transitions the token transitions of every state
+        //@param epsilon_transitions the epsilon transitions of every state, 
+        //                           states past its end have none
+        //@param accepting_states the set of accepting states
+        nfa_automatum(const nfa_table_t& transitions, const epsilon_table_t& epsilon_transitions, 
+                      const std::unordered_set<state_t>& accepting_states)
+            : _M_transitions(transitions), _M_epsilon(epsilon_transitions), _M_accepting(accepting_states)
+        {
+            _M_epsilon.resize(_M_transitions.size());
+        }
+
+        //Returns the states the NFA can move to from a state on a token, 
+        //not following epsilon transitions.
+        //@param s the NFA's current state
+        //@param tok the token just read.
+        const std::vector<state_t>& delta(state_t s, const _TokTp& tok) const
+        {
+            static const std::vector<state_t> none;
+            const auto& row = _M_transitions[s];
+            auto it = row.find(tok);
+            return it == row.end() ? none : it->second;
+        }
+
+        //Returns the states the NFA can move to from a state without 
+        //reading a token.
+        //@param s the NFA's current state
+        const std::vector<state_t>& epsilon(state_t s) const
+        {
+            return _M_epsilon[s];
+        }
+
+        //Returns true if the state is in the accepting states of the NFA.
+        //
+        //@param s the state to be checked
+        //@return true if the state is in the accepting state
+        bool is_accepting_state(state_t s) const
+        {
+            return _M_accepting.find(s) != _M_accepting.end();
+        }
+
+        //Returns the number of states of the NFA.
+        std::size_t size() const
+        {
+            return _M_transitions.size();
+        }
+
+        const nfa_table_t& get_table() const
+        {
+            return _M_transitions;
+        }
+
+        const epsilon_table_t& get_epsilon_table() const
+        {
+            return _M_epsilon;
+        }
+
+        const std::unordered_set<state_t>& get_accepting_states() const
+        {
+            return _M_accepting;
+        }
+
+        private:
+            //The token transitions of the NFA
+            nfa_table_t _M_transitions;
+            //The epsilon transitions of the NFA
+            epsilon_table_t _M_epsilon;
+            //The accepting states of the NFA
+            std::unordered_set<state_t> _M_accepting;
     };
 
     //Given a set of regular expressions, constructs a non-deterministic
@@ -88,7 +306,7 @@ namespace alegna::lexer::automata
     //@param regex the set of regular expressions 
     //@return a non-deterministic finite automatum that represents the 
     //        regular expressions
-    automatum<char> construct_nfa(const std::vector<std::vector<char>>& regex);
+    nfa_automatum<char> construct_nfa(const std::vector<std::vector<char>>& regex);
 
     template<typename _TokTp>
     automatum<_TokTp> merge_nfa(const automatum<_TokTp>& lhs, const automatum<_TokTp>& rhs, const std::string& op)
@@ -128,7 +346,7 @@ namespace alegna::lexer::automata
             //Create merged automatum
             return automatum<_TokTp>(lhs_table, final_accepting_states);
         }
-        else if (op == '|') //Union
+        else if (op == "|") //Union
         {
             //Create state transition table for new automatum
             typename automatum<_TokTp>::fa_table_t new_table;
@@ -162,7 +380,7 @@ namespace alegna::lexer::automata
             //Add epsilon transition to beginning of lhs and rhs 
             new_table.push_back(
                 {automatum<_TokTp>::EPSILON, 1},
-                {automuam<_TokTp>::EPSILON, 1 + num_lhs_states}
+                {automatum<_TokTp>::EPSILON, 1 + num_lhs_states}
             );
             //Add in lhs_states 
             new_table.insert(new_table.end(), lhs_table.begin(), lhs_table.end());
@@ -173,12 +391,121 @@ namespace alegna::lexer::automata
         }
     }
 
+    //Adds every state that can be reached from a set of states using 
+    //only epsilon transitions to the set. The set is sorted afterwards.
+    //
+    //@param nfa the non-deterministic finite automatum 
+    //@param states the set of states, as a vector without duplicates
+    template <typename _TokTp>
+    void epsilon_closure(const nfa_automatum<_TokTp>& nfa, std::vector<state_t>& states)
+    {
+        std::vector<bool> in_closure(nfa.size(), false);
+        for (const auto s: states)
+            in_closure[s] = true;
+        //states grows as new states are reached
+        for (std::size_t i = 0; i < states.size(); ++i)
+        {
+            for (const auto t: nfa.epsilon(states[i]))
+            {
+                if (!in_closure[t])
+                {
+                    in_closure[t] = true;
+                    states.push_back(t);
+                }
+            }
+        }
+        std::sort(states.begin(), states.end());
+    }
+
+    //Given a non-deterministic finite automatic, constructs a 
+    //deterministic finite automatum (DFA) that represents the same 
+    //set of regular expressions. The DFA can be used in a lexer or 
+    //parser. Uses the subset construction.
+    //
+    //@param nfa the non-deterministic finite automatum
+    //@param nfa_states set to the sorted NFA states that each DFA 
+    //                  state represents
+    //@return a deterministic finite automatum that accepts the same 
+    //        language as nfa
+    template <typename _TokTp>
+    automatum<_TokTp> construct_dfa(const nfa_automatum<_TokTp>& nfa, std::vector<std::vector<state_t>>& nfa_states)
+    {
+        const auto& nfa_table = nfa.get_table();
+        nfa_states.clear();
+        if (nfa_table.empty())
+            return automatum<_TokTp>({}, {});
+
+        //Every token the NFA has a transition on 
+        std::vector<_TokTp> alphabet;
+        for (const auto& row: nfa_table)
+        {
+            for (const auto& transition: row)
+            {
+                if (std::find(alphabet.begin(), alphabet.end(), transition.first) == alphabet.end())
+                    alphabet.push_back(transition.first);
+            }
+        }
+
+        std::map<std::vector<state_t>, state_t> dfa_state_ids;
+        typename automatum<_TokTp>::fa_table_t dfa_table;
+        std::unordered_set<state_t> accepting_states;
+
+        std::vector<state_t> start = {0};
+        epsilon_closure(nfa, start);
+        dfa_state_ids.emplace(start, 0);
+        nfa_states.push_back(start);
+        dfa_table.emplace_back();
+
+        //nfa_states grows as new DFA states are found
+        for (std::size_t i = 0; i < nfa_states.size(); ++i)
+        {
+            for (const auto s: nfa_states[i])
+            {
+                if (nfa.is_accepting_state(s))
+                {
+                    accepting_states.insert(static_cast<state_t>(i));
+                    break;
+                }
+            }
+            for (const auto& tok: alphabet)
+            {
+                std::vector<state_t> next;
+                for (const auto s: nfa_states[i])
+                {
+                    for (const auto t: nfa.delta(s, tok))
+                    {
+                        if (std::find(next.begin(), next.end(), t) == next.end())
+                            next.push_back(t);
+                    }
+                }
+                if (next.empty())
+                    continue;
+                epsilon_closure(nfa, next);
+                auto id = dfa_state_ids.find(next);
+                if (id == dfa_state_ids.end())
+                {
+                    id = dfa_state_ids.emplace(next, static_cast<state_t>(nfa_states.size())).first;
+                    nfa_states.push_back(next);
+                    dfa_table.emplace_back();
+                }
+                dfa_table[i].emplace(tok, id->second);
+            }
+        }
+        automatum<_TokTp> dfa(dfa_table, accepting_states);
+        dfa.pack();
+        return dfa;
+    }
+
     //Given a non-deterministic finite automatic, constructs a 
     //deterministic finite automatum (DFA) that represents the same 
     //set of regular expressions. The DFA can be used in a lexer or 
     //parser.
     template <typename _TokTp>
-    automatum<_TokTp> construct_dfa(const automatum<_TokTp>& nfa);
+    automatum<_TokTp> construct_dfa(const nfa_automatum<_TokTp>& nfa)
+    {
+        std::vector<std::vector<state_t>> nfa_states;
+        return construct_dfa(nfa, nfa_states);
+    }
 }
 
 
@@ -37,19 +37,26 @@ namespace alegna::lexer
                 typedef tok_type token_type;
 
                 tok_type _M_type;
-                index_t _M_line;
-                index_t _M_start_col;
-                index_t _M_end_col;
+                //Byte offset of the start of the token in the source text.
+                //Use lexer::locate to find its line and column.
+                index_t _M_offset;
                 value_type _M_value;
 
                 friend std::ostream& operator<<(std::ostream& os, const token& t);
             };
+
+            //A line and column in the source text. Both start at 0.
+            struct source_location
+            {
+                index_t _M_line;
+                index_t _M_col;
+            };
         public:
             //Creates a new lexer that uses the specified 
             //deterministic finite automatum (DFA) to lex source text.
             //
             //@param dfa the DFA used to lex the source text.
-            lexer(const dfa_t& dfa, const std::unordered_map<state_t, tok_type>& tok_types);
+            lexer(const dfa_t& dfa, const std::unordered_map<automata::state_t, tok_type>& tok_types);
 
             //Creates a new lexer that uses the specified 
             //deterministic finite automatum (DFA) to lex the specified 
@@ -57,7 +64,7 @@ namespace alegna::lexer
             //
             //@param dfa the DFA used to lex the source text. 
             //@param src the source text to be lexed
-            lexer(const dfa_t& dfa, const std::unordered_map<state_t, tok_type>& tok_types, const std::string& src);
+            lexer(const dfa_t& dfa, const std::unordered_map<automata::state_t, tok_type>& tok_types, const std::string& src);
 
             //Sets the source text for the lexer to source 
             //and resets the lexer to the beginning of the source.
@@ -70,20 +77,58 @@ namespace alegna::lexer
             //Uses move semantics.
             //
             //@param src the source to lex
-            void set_src(std::string&& src) noexcept;
+            void set_src(std::string&& src);
 
             //Lexes the source text and returns a vector 
-            //contaning the tokens in the source text.
+            //contaning the tokens in the source text. The last 
+            //token is an eEOF token at the end of the source text.
             //
             //@return a vector containing the tokens of the source text
             std::vector<token> lex();
+
+            //Returns the line and column of a byte offset in the 
+            //source text. Only meant to be used when reporting 
+            //diagnostics, lexing itself does not track lines.
+            //
+            //@param offset a byte offset in the source text
+            //@return the line and column of offset
+            source_location locate(index_t offset) const;
+
+            //Runs the lexer's DFA over a training corpus and renumbers 
+            //its states so that the states used most often on the 
+            //corpus are next to each other in the transition table. 
+            //The reordered DFA replaces the lexer's DFA. Does not 
+            //change which tokens the lexer produces.
+            //
+            //@param corpus source text representative of what will be lexed
+            void reorder_states(const std::string& corpus);
+
+            //Returns the DFA used to lex the source text.
+            const dfa_t& get_dfa() const
+            {
+                return _M_dfa;
+            }
+
+            //Returns the token type of every accepting state of the DFA.
+            const std::unordered_map<automata::state_t, tok_type>& get_tok_types() const
+            {
+                return _M_tok_types;
+            }
         private:
-            //Determines the next token in the src text.
+            //Determines the next token in the src text and advances 
+            //the lexer past it. Skips the whitespace before the token.
+            //Returns an eError token if no token matches.
             //
             //@return the next token in the source text
             token next_token();
 
-            token make_token(automata::state_t s, const std::string& value) const;
+            //Creates a token of the type of an accepting state.
+            //
+            //@param s the accepting state the DFA stopped in
+            //@param start the offset of the first character of the token
+            //@param value the text of the token
+            //@return the token
+            token make_token(automata::state_t s, index_t start, const std::string& value) const;
 
             //Returns the character amt ahead of the current 
             //position in the lexer (or the EOF token if 
@@ -96,11 +141,18 @@ namespace alegna::lexer
             //        position of the lexer.
             char lookahead(index_t amt) const;
 
+            //Advances the lexer by one character.
+            void advance();
+
+            //Records the offset of the first character of every line 
+            //in the source text in _M_line_starts.
+            void index_lines();
+
         private:
             index_t _M_pos;
-            index_t _M_col;
-            index_t _M_line;
             std::string _M_src;
+            //Offset of the first character of every line in _M_src
+            std::vector<index_t> _M_line_starts;
             std::unordered_map<automata::state_t, tok_type> _M_tok_types;
             dfa_t _M_dfa;
     };
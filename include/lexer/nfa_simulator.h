@@ -0,0 +1,81 @@
+#ifndef NFA_SIMULATOR_H
+#define NFA_SIMULATOR_H 1
+
+#include "finite_automata.h"
+#include <vector>
+
+namespace alegna::lexer::automata
+{
+    //A class that runs a non-deterministic finite automatum (NFA) directly,
+    //by keeping track of the set of states the NFA could be in. Much slower
+    //than running the equivalent DFA, but does not depend on construct_dfa,
+    //so it can be used to check DFAs and their table layouts.
+    //@param _TokTp the type of tokens used in the automatum.
+    template<typename _TokTp>
+    class nfa_simulator
+    {
+        public:
+            //A set of NFA states, sorted and without duplicates.
+            typedef std::vector<state_t> state_set;
+
+            //Creates a new nfa_simulator for the specified NFA. The NFA
+            //must outlive the simulator.
+            //
+            //@param nfa the NFA to be simulated
+            explicit nfa_simulator(const nfa_automatum<_TokTp>& nfa)
+                : _M_nfa(nfa)
+            {
+
+            }
+
+            //Returns the set of states the NFA is in before reading any token.
+            state_set start() const
+            {
+                state_set states;
+                if (_M_nfa.size() != 0)
+                    states.push_back(0);
+                epsilon_closure(_M_nfa, states);
+                return states;
+            }
+
+            //Finds the set of states the NFA can be in after reading a token.
+            //Returns an empty set if the NFA has no valid transition. Epsilon
+            //transitions are only followed after the token is read, they 
+            //never consume a token.
+            //
+            //@param states the set of states the NFA is currently in
+            //@param tok the token just read
+            //@return the set of states after reading tok
+            state_set delta(const state_set& states, const _TokTp& tok) const
+            {
+                state_set next;
+                for (const auto s: states)
+                {
+                    for (const auto t: _M_nfa.delta(s, tok))
+                    {
+                        if (std::find(next.begin(), next.end(), t) == next.end())
+                            next.push_back(t);
+                    }
+                }
+                epsilon_closure(_M_nfa, next);
+                return next;
+            }
+
+            //Returns true if any state in the set is an accepting state.
+            //
+            //@param states the set of states to be checked
+            //@return true if the NFA accepts in one of the states
+            bool is_accepting(const state_set& states) const
+            {
+                return std::any_of(states.begin(), states.end(), [this](state_t s) {
+                    return _M_nfa.is_accepting_state(s);
+                });
+            }
+
+        private:
+            //The NFA being simulated
+            const nfa_automatum<_TokTp>& _M_nfa;
+    };
+}
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef REGEX_OPTIMIZER_H
+#define REGEX_OPTIMIZER_H 1
+
+#include <vector>
+#include <map>
+#include <tuple>
+
+namespace alegna::lexer::regex
+{
+    //A class that simplifies regular expressions in postfix notation
+    //(as produced by regex_parser) before they are converted into a
+    //non-deterministic finite automatum. Factors common prefixes and
+    //suffixes out of alternations, so for|foreach|format becomes
+    //for(\0|each|mat), and removes duplicate alternatives.
+    //
+    //Subexpressions are interned across all regular expressions passed
+    //to the same regex_optimizer, so a subexpression that appears in
+    //several rules is only simplified once. This is only memoization:
+    //every rule is still written out as its own postfix regex, so a
+    //subexpression shared by several rules is still built once per
+    //rule by construct_nfa.
+    //
+    //Nothing calls this pass yet. Merging the rules into one shared
+    //automatum, so that common subexpressions are built only once, is
+    //deferred until construct_nfa is implemented.
+    class regex_optimizer
+    {
+        public:
+            //Simplifies a single regular expression in postfix notation.
+            //
+            //May throw a std::invalid_regex_exception if the regex is not
+            //a valid postfix regex.
+            //
+            //@param regex the postfix regex to be simplified
+            //@return a postfix representation of an equivalent regex
+            std::vector<char> optimize_regex(const std::vector<char>& regex);
+
+            //Simplifies every regular expression in a set of regular
+            //expressions in postfix notation.
+            //
+            //May throw a std::invalid_regex_exception if any regex is not
+            //a valid postfix regex.
+            //
+            //@param regex the set of postfix regexes to be simplified
+            //@return the simplified regexes, in the same order
+            std::vector<std::vector<char>> optimize(const std::vector<std::vector<char>>& regex);
+
+        private:
+            typedef std::size_t node_id;
+
+            //The kind of a node in a regex syntax tree.
+            enum class node_kind
+            {
+                eEpsilon,
+                eLiteral,
+                eConcat,
+                eUnion,
+                eStar
+            };
+
+            //A node in a regex syntax tree. Nodes are interned, so two
+            //structurally equal subexpressions have the same node_id.
+            struct node
+            {
+                node_kind _M_kind;
+                char _M_value;
+                node_id _M_lhs;
+                node_id _M_rhs;
+            };
+
+            typedef std::tuple<node_kind, char, node_id, node_id> node_key;
+
+            //Returns the id of the node with the specified contents,
+            //creating it if it does not exist yet.
+            node_id make_node(node_kind kind, char value = 0, node_id lhs = 0, node_id rhs = 0);
+
+            //Builds a syntax tree from a regex in postfix notation.
+            //@param regex the postfix regex
+            //@return the root of the syntax tree
+            node_id build_tree(const std::vector<char>& regex);
+
+            //Returns the simplified form of a subexpression.
+            //@param n the subexpression to be simplified
+            //@return the root of the simplified subexpression
+            node_id simplify(node_id n);
+
+            //Factors common prefixes and suffixes out of a list of
+            //alternatives, each given as a sequence of concatenated factors.
+            //@param alternatives the alternatives of a union
+            //@return the root of the factored union
+            node_id factor(std::vector<std::vector<node_id>> alternatives);
+
+            //Appends the alternatives of a (possibly nested) union to out.
+            void flatten_union(node_id n, std::vector<node_id>& out) const;
+
+            //Appends the factors of a (possibly nested) concatenation to out.
+            void flatten_concat(node_id n, std::vector<node_id>& out) const;
+
+            //Builds a concatenation of a sequence of factors.
+            node_id make_concat(const std::vector<node_id>& factors);
+
+            //Builds a union of a list of alternatives.
+            node_id make_union(const std::vector<node_id>& alternatives);
+
+            //Writes the postfix representation of a subexpression to out.
+            void emit(node_id n, std::vector<char>& out) const;
+        private:
+           constexpr static char __epsilon = '\0';
+        private:
+           std::vector<node> _M_nodes;
+           std::map<node_key, node_id> _M_interned;
+           std::map<node_id, node_id> _M_simplified;
+    };
+}
+
+#endif
@@ -28,7 +28,9 @@ namespace alegna::lexer::regex
             //stream, returns nothing. 
             //
             //May throw a std::invalid_regex_exception if it the regex it
-            //is attempting to parse is not a valid regex.
+            //is attempting to parse is not a valid regex, such as a regex 
+            //with an operator missing an operand, unbalanced parentheses 
+            //or an empty line.
             //
             //@return a postfix representation of the regular expression
             //        currently referenced by the stored std::istream object.
@@ -51,6 +53,18 @@ namespace alegna::lexer::regex
             //@param str the regex to be preprocessed
             void preprocess(std::string& str);
 
+            //Expands Unicode character classes such as 
+            //[\u{C0}-\u{24F}\u{370}-\u{3FF}] into alternations of 
+            //UTF-8 byte sequences. A class is a list of code points 
+            //\u{hex} and ranges \u{hex}-\u{hex}. See utf8_class for 
+            //the code points that are rejected.
+            //
+            //May throw a std::invalid_regex_exception if a Unicode 
+            //character class is malformed.
+            //
+            //@param str the regex to be expanded
+            void expand_unicode_classes(std::string& str);
+
             //Returns the priority of a character.
             //@param c the character whose priority will be returned
             //@return the priority of the specified character.
@@ -60,6 +74,24 @@ namespace alegna::lexer::regex
         private:
            std::istream& _M_in;
     };
+
+    //Converts a range of Unicode code points into a regex that matches 
+    //the UTF-8 encoding of every code point in the range, one byte at 
+    //a time. Lets the lexer match Unicode characters with a DFA over 
+    //bytes, without decoding its input. Surrogate code points are 
+    //never matched.
+    //
+    //May throw a std::invalid_regex_exception if lo > hi, if hi is not 
+    //a valid code point, or if the range contains a code point that is 
+    //also a regex operator: \0 (epsilon), (, ), |, * or ?. The regex 
+    //syntax has no escapes, so those characters cannot be matched by a 
+    //Unicode class.
+    //
+    //@param lo the first code point in the range
+    //@param hi the last code point in the range
+    //@return an infix regex over bytes, such as (\xC3(\xA9|\xAA)) for 
+    //        the range U+E9 to U+EA
+    std::string utf8_class(char32_t lo, char32_t hi);
 }
 
 #endif
\ No newline at end of file
@@ -1,15 +1,162 @@
 #include "lexer/finite_automata.h"
 #include <deque>
+#include <numeric>
 
 namespace alegna::lexer::automata
 {
-    automatum<char> construct_nfa(const std::vector<std::vector<char>>& regex)
+    namespace
+    {
+        //Marks an unused entry of a comb vector
+        constexpr state_t FREE = -1;
+
+        //Returns the most common next state of a row, counting every 
+        //missing transition as a transition to the error state.
+        state_t default_transition(const std::unordered_map<char, state_t>& row)
+        {
+            std::unordered_map<state_t, std::size_t> counts;
+            counts[automatum<char>::ERROR] = 256 - row.size();
+            for(const auto& transition: row)
+                ++counts[transition.second];
+            auto most_common = std::max_element(counts.begin(), counts.end(), 
+                [](const auto& lhs, const auto& rhs) {
+                    return lhs.second < rhs.second || (lhs.second == rhs.second && lhs.first > rhs.first);
+                });
+            return most_common->first;
+        }
+
+        //Returns the first free entry of a comb vector at or after i. 
+        //next_free links each used entry to a later entry, and is 
+        //shortened on every lookup.
+        std::size_t find_free(std::vector<std::size_t>& next_free, std::size_t i)
+        {
+            std::size_t root = i;
+            while (root < next_free.size() && next_free[root] != root)
+                root = next_free[root];
+            while (i < next_free.size() && next_free[i] != i)
+            {
+                std::size_t next = next_free[i];
+                next_free[i] = root;
+                i = next;
+            }
+            return root;
+        }
+    }
+
+    packed_table::packed_table(const std::vector<std::unordered_map<char, state_t>>& rows)
+    {
+        if (rows.empty())
+            return;
+        std::size_t exceptions = 0;
+        for(const auto& row: rows)
+        {
+            state_t def = default_transition(row);
+            std::size_t default_count = def == automatum<char>::ERROR ? 256 - row.size() : 0;
+            for(const auto& transition: row)
+                default_count += transition.second == def;
+            exceptions += 256 - default_count;
+        }
+        double density = static_cast<double>(exceptions) / (256.0 * rows.size());
+        if (density > DENSE_THRESHOLD)
+            pack_dense(rows);
+        else 
+            pack_comb(rows);
+    }
+
+    void packed_table::pack_dense(const std::vector<std::unordered_map<char, state_t>>& rows)
+    {
+        _M_layout = layout::eDense;
+        _M_next.assign(rows.size() * 256, automatum<char>::ERROR);
+        for(std::size_t s = 0; s < rows.size(); ++s)
+        {
+            for(const auto& transition: rows[s])
+                _M_next[(s << 8) | static_cast<unsigned char>(transition.first)] = transition.second;
+        }
+    }
+
+    void packed_table::pack_comb(const std::vector<std::unordered_map<char, state_t>>& rows)
+    {
+        _M_layout = layout::eComb;
+        _M_base.assign(rows.size(), 0);
+        _M_default.resize(rows.size());
+
+        //Bytes of each state's transitions that differ from its default
+        std::vector<std::vector<std::pair<std::size_t, state_t>>> exceptions(rows.size());
+        for(std::size_t s = 0; s < rows.size(); ++s)
+        {
+            _M_default[s] = default_transition(rows[s]);
+            for(const auto& transition: rows[s])
+            {
+                if (transition.second != _M_default[s])
+                    exceptions[s].emplace_back(static_cast<unsigned char>(transition.first), transition.second);
+            }
+            //Missing transitions go to the error state
+            if (_M_default[s] != automatum<char>::ERROR)
+            {
+                for(std::size_t b = 0; b < 256; ++b)
+                {
+                    if (rows[s].find(static_cast<char>(b)) == rows[s].end())
+                        exceptions[s].emplace_back(b, automatum<char>::ERROR);
+                }
+            }
+            std::sort(exceptions[s].begin(), exceptions[s].end());
+        }
+
+        //Rows are placed in state order, so states with close numbers 
+        //(such as the hot states put first by dfa_profiler::hot_order) 
+        //get close bases and share cache lines. Maps each entry to the 
+        //first free entry at or after it, entries past the end are free.
+        std::vector<std::size_t> next_free;
+        for(std::size_t s = 0; s < rows.size(); ++s)
+        {
+            const auto& row = exceptions[s];
+            if (row.empty())
+                continue;
+            //Try every base that puts the row's first transition in a 
+            //free entry until the rest of the row fits too
+            std::size_t first = find_free(next_free, row.front().first);
+            while (true)
+            {
+                std::size_t base = first - row.front().first;
+                bool fits = std::all_of(row.begin() + 1, row.end(), [&](const auto& entry) {
+                    return base + entry.first >= _M_check.size() || _M_check[base + entry.first] == FREE;
+                });
+                if (fits)
+                    break;
+                first = find_free(next_free, first + 1);
+            }
+            std::size_t base = first - row.front().first;
+            if (_M_check.size() < base + 256)
+            {
+                std::size_t old_size = next_free.size();
+                _M_check.resize(base + 256, FREE);
+                _M_next.resize(base + 256, automatum<char>::ERROR);
+                next_free.resize(base + 256);
+                std::iota(next_free.begin() + old_size, next_free.end(), old_size);
+            }
+            _M_base[s] = static_cast<state_t>(base);
+            for(const auto& entry: row)
+            {
+                _M_check[base + entry.first] = static_cast<state_t>(s);
+                _M_next[base + entry.first] = entry.second;
+                next_free[base + entry.first] = base + entry.first + 1;
+            }
+        }
+
+        //Every state may be looked up at base + 255
+        if (_M_check.size() < 256)
+        {
+            _M_check.resize(256, FREE);
+            _M_next.resize(256, automatum<char>::ERROR);
+        }
+    }
+
+    nfa_automatum<char> construct_nfa(const std::vector<std::vector<char>>& regex)
     {
         
     }
 
-    automatum<char> construct_sub_nfa(std::vector<char>& regex)
+    nfa_automatum<char> construct_sub_nfa(std::vector<char>& regex)
     {
-        std::deque<automatum<char>> nfa_stack;
+        std::deque<nfa_automatum<char>> nfa_stack;
     }
-}
\ No newline at end of file
+}
@@ -1,46 +1,81 @@
 #include "lexer/lexer.h"
+#include "lexer/dfa_profiler.h"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
 
 namespace alegna::lexer
 {
     using state_t = automata::state_t;
 
+    lexer::lexer(const dfa_t& dfa, const std::unordered_map<state_t, tok_type>& tok_types)
+        : _M_pos(0), _M_tok_types(tok_types), _M_dfa(dfa)
+    {
+        if (!_M_dfa.is_packed())
+            _M_dfa.pack();
+        index_lines();
+    }
+
+    lexer::lexer(const dfa_t& dfa, const std::unordered_map<state_t, tok_type>& tok_types, const std::string& src)
+        : _M_pos(0), _M_src(src), _M_tok_types(tok_types), _M_dfa(dfa)
+    {
+        if (!_M_dfa.is_packed())
+            _M_dfa.pack();
+        index_lines();
+    }
+
     void lexer::set_src(const std::string& src)
     {
         _M_pos = 0;
-        _M_line = 0;
-        _M_col = 0;
         _M_src = src;
+        index_lines();
     }
 
-    void lexer::set_src(std::string&& src) noexcept
+    void lexer::set_src(std::string&& src)
     {
         _M_pos = 0;
-        _M_line = 0;
-        _M_col = 0;
-        _M_src = src;
+        _M_src = std::move(src);
+        index_lines();
+    }
+
+    std::vector<lexer::token> lexer::lex()
+    {
+        std::vector<token> tokens;
+        _M_pos = 0;
+        do
+            tokens.push_back(next_token());
+        while (tokens.back()._M_offset < _M_src.length());
+        return tokens;
     }
 
     lexer::token lexer::next_token()
     {
+        //Skip the whitespace before the token
+        while (_M_pos < _M_src.length() && isspace(_M_src[_M_pos]))
+            advance();
+        const index_t start = _M_pos;
+        if (_M_pos == _M_src.length())
+            return lexer::token{tok_type::eEOF, start, std::string()};
+
         automata::state_t curr_state = 0;
         std::string value = "";
-        while (true)
+        while (_M_pos < _M_src.length())
         {
             char c = _M_src[_M_pos];
             if (!isspace(c))
                 value += c;
             curr_state = _M_dfa.delta(curr_state, c);
-            if (_M_dfa.is_accepting_state(curr_state))
-                return make_token(curr_state, value);
-            if(curr_state == automata::automatum<char>::ERROR)
-                int i = 0; //Handle error
-            else if (_M_pos == _M_src.length())
-                int i = 0; //Missing characters to make a token 
             advance();
+            if (_M_dfa.is_accepting_state(curr_state))
+                return make_token(curr_state, start, value);
+            if (curr_state == automata::automatum<char>::ERROR)
+                break;
         }
+        //No token matches, or the source ends in the middle of a token
+        return lexer::token{tok_type::eError, start, value};
     }
 
-    lexer::token lexer::make_token(state_t s, const std::string& value) const 
+    lexer::token lexer::make_token(state_t s, index_t start, const std::string& value) const 
     {
        auto tok_type_it = _M_tok_types.find(s);
        if (tok_type_it != _M_tok_types.end())
@@ -49,13 +84,14 @@ namespace alegna::lexer
            switch (tok_type)
            {
                 case lexer::tok_type::eInt:
-                    return lexer::token{tok_type, _M_line, _M_col - value.length(), _M_col, std::stoi(value)};
+                    return lexer::token{tok_type, start, std::stoi(value)};
                 case lexer::tok_type::eFloat:
-                    return lexer::token{tok_type, _M_line, _M_col - value.length(), _M_col, std::stoi(value)};
+                    return lexer::token{tok_type, start, std::stoi(value)};
                 default:
-                    return lexer::token{tok_type, _M_line, _M_col - value.length(), _M_col, value};
+                    return lexer::token{tok_type, start, value};
            }
        }
+       return lexer::token{tok_type::eError, start, value};
     }
 
     char lexer::lookahead(index_t amt) const 
@@ -68,15 +104,43 @@ namespace alegna::lexer
     void lexer::advance()
     {
         if (_M_pos >= _M_src.length()) return;
-        if (_M_src[_M_pos] == '\n')
-        {
-           ++_M_line;
-            _M_col = 0;
-        }
-        else 
+        ++_M_pos;
+    }
+
+    void lexer::index_lines()
+    {
+        _M_line_starts.clear();
+        _M_line_starts.push_back(0);
+        //memchr is vectorized by the standard library, which is much 
+        //faster than testing every character for a newline
+        const char* begin = _M_src.data();
+        const char* end = begin + _M_src.length();
+        const char* nl = begin;
+        while ((nl = static_cast<const char*>(std::memchr(nl, '\n', end - nl))) != nullptr)
         {
-            ++_M_col;
+            ++nl;
+            _M_line_starts.push_back(static_cast<index_t>(nl - begin));
         }
-        ++_M_pos;
+    }
+
+    lexer::source_location lexer::locate(index_t offset) const
+    {
+        //The line containing offset is the last line starting at or before it
+        auto line_it = std::upper_bound(_M_line_starts.begin(), _M_line_starts.end(), offset) - 1;
+        index_t line = static_cast<index_t>(line_it - _M_line_starts.begin());
+        return source_location{line, offset - *line_it};
+    }
+
+    void lexer::reorder_states(const std::string& corpus)
+    {
+        automata::dfa_profiler<char> profiler(_M_dfa);
+        profiler.profile(corpus.begin(), corpus.end());
+        auto new_numbers = profiler.hot_order();
+
+        std::unordered_map<state_t, tok_type> new_tok_types;
+        for (const auto& tok: _M_tok_types)
+            new_tok_types.emplace(new_numbers[tok.first], tok.second);
+        _M_tok_types = std::move(new_tok_types);
+        _M_dfa = automata::renumber_states(_M_dfa, new_numbers);
     }
 }
\ No newline at end of file
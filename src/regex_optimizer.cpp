@@ -0,0 +1,276 @@
+#include "lexer/regex_optimizer.h"
+#include "exceptions/exceptions.h"
+#include <algorithm>
+
+namespace alegna::lexer::regex
+{
+    std::vector<char> regex_optimizer::optimize_regex(const std::vector<char>& regex)
+    {
+        std::vector<char> out;
+        if (regex.empty())
+            return out;
+        emit(simplify(build_tree(regex)), out);
+        return out;
+    }
+
+    std::vector<std::vector<char>> regex_optimizer::optimize(const std::vector<std::vector<char>>& regex)
+    {
+        std::vector<std::vector<char>> out;
+        out.reserve(regex.size());
+        for(const auto& ex: regex)
+            out.push_back(optimize_regex(ex));
+        return out;
+    }
+
+    regex_optimizer::node_id regex_optimizer::make_node(node_kind kind, char value, node_id lhs, node_id rhs)
+    {
+        node_key key(kind, value, lhs, rhs);
+        auto it = _M_interned.find(key);
+        if (it != _M_interned.end())
+            return it->second;
+        node_id id = _M_nodes.size();
+        _M_nodes.push_back(node{kind, value, lhs, rhs});
+        _M_interned.emplace(key, id);
+        return id;
+    }
+
+    regex_optimizer::node_id regex_optimizer::build_tree(const std::vector<char>& regex)
+    {
+        std::vector<node_id> stack;
+        for(const auto c: regex)
+        {
+            if (c == '*')
+            {
+                if (stack.empty())
+                    throw alegna::exceptions::invalid_regex_exception();
+                stack.back() = make_node(node_kind::eStar, 0, stack.back());
+            }
+            else if (c == '?' || c == '|')
+            {
+                if (stack.size() < 2)
+                    throw alegna::exceptions::invalid_regex_exception();
+                node_id rhs = stack.back();
+                stack.pop_back();
+                node_id lhs = stack.back();
+                stack.back() = make_node(c == '?' ? node_kind::eConcat : node_kind::eUnion, 0, lhs, rhs);
+            }
+            else if (c == __epsilon)
+                stack.push_back(make_node(node_kind::eEpsilon));
+            else
+                stack.push_back(make_node(node_kind::eLiteral, c));
+        }
+        if (stack.size() != 1)
+            throw alegna::exceptions::invalid_regex_exception();
+        return stack.back();
+    }
+
+    regex_optimizer::node_id regex_optimizer::simplify(node_id n)
+    {
+        auto memo = _M_simplified.find(n);
+        if (memo != _M_simplified.end())
+            return memo->second;
+
+        //Copy the node, _M_nodes may grow while simplifying
+        node current = _M_nodes[n];
+        node_id result = n;
+        switch (current._M_kind)
+        {
+            case node_kind::eStar:
+                result = make_node(node_kind::eStar, 0, simplify(current._M_lhs));
+                break;
+            case node_kind::eConcat:
+            {
+                std::vector<node_id> factors;
+                flatten_concat(simplify(current._M_lhs), factors);
+                flatten_concat(simplify(current._M_rhs), factors);
+                result = make_concat(factors);
+                break;
+            }
+            case node_kind::eUnion:
+            {
+                std::vector<node_id> branches;
+                flatten_union(n, branches);
+                //Simplifying a branch may turn it into a union itself
+                std::vector<node_id> simplified;
+                for(const auto branch: branches)
+                    flatten_union(simplify(branch), simplified);
+                std::vector<std::vector<node_id>> alternatives;
+                for(const auto branch: simplified)
+                {
+                    alternatives.emplace_back();
+                    flatten_concat(branch, alternatives.back());
+                }
+                result = factor(std::move(alternatives));
+                break;
+            }
+            default:
+                break;
+        }
+        _M_simplified.emplace(n, result);
+        return result;
+    }
+
+    regex_optimizer::node_id regex_optimizer::factor(std::vector<std::vector<node_id>> alternatives)
+    {
+        //Remove duplicate alternatives, keeping the first occurrence
+        std::vector<std::vector<node_id>> unique;
+        for(auto& alternative: alternatives)
+        {
+            if (std::find(unique.begin(), unique.end(), alternative) == unique.end())
+                unique.push_back(std::move(alternative));
+        }
+        if (unique.size() == 1)
+            return make_concat(unique.front());
+
+        std::vector<node_id> parts;
+
+        //Group alternatives by their first factor, in order of appearance
+        std::vector<std::pair<node_id, std::vector<std::size_t>>> prefix_groups;
+        for(std::size_t i = 0; i < unique.size(); ++i)
+        {
+            if (unique[i].empty())
+            {
+                parts.push_back(make_node(node_kind::eEpsilon));
+                continue;
+            }
+            auto group = std::find_if(prefix_groups.begin(), prefix_groups.end(),
+                                      [&](const auto& g) { return g.first == unique[i].front(); });
+            if (group == prefix_groups.end())
+                prefix_groups.push_back({unique[i].front(), {i}});
+            else
+                group->second.push_back(i);
+        }
+
+        //Alternatives that share a prefix become prefix(tail1|tail2|...)
+        std::vector<std::size_t> remaining;
+        for(const auto& group: prefix_groups)
+        {
+            if (group.second.size() == 1)
+            {
+                remaining.push_back(group.second.front());
+                continue;
+            }
+            std::vector<std::vector<node_id>> tails;
+            for(const auto i: group.second)
+                tails.emplace_back(unique[i].begin() + 1, unique[i].end());
+            node_id tail = factor(std::move(tails));
+            parts.push_back(make_concat({group.first, tail}));
+        }
+
+        //Group the rest by their last factor
+        std::vector<std::pair<node_id, std::vector<std::size_t>>> suffix_groups;
+        for(const auto i: remaining)
+        {
+            auto group = std::find_if(suffix_groups.begin(), suffix_groups.end(),
+                                      [&](const auto& g) { return g.first == unique[i].back(); });
+            if (group == suffix_groups.end())
+                suffix_groups.push_back({unique[i].back(), {i}});
+            else
+                group->second.push_back(i);
+        }
+
+        //Alternatives that share a suffix become (head1|head2|...)suffix
+        for(const auto& group: suffix_groups)
+        {
+            if (group.second.size() == 1)
+            {
+                const auto& alternative = unique[group.second.front()];
+                parts.push_back(make_concat(alternative));
+                continue;
+            }
+            std::vector<std::vector<node_id>> heads;
+            for(const auto i: group.second)
+                heads.emplace_back(unique[i].begin(), unique[i].end() - 1);
+            node_id head = factor(std::move(heads));
+            parts.push_back(make_concat({head, group.first}));
+        }
+
+        return make_union(parts);
+    }
+
+    void regex_optimizer::flatten_union(node_id n, std::vector<node_id>& out) const
+    {
+        const node& current = _M_nodes[n];
+        if (current._M_kind != node_kind::eUnion)
+        {
+            out.push_back(n);
+            return;
+        }
+        flatten_union(current._M_lhs, out);
+        flatten_union(current._M_rhs, out);
+    }
+
+    void regex_optimizer::flatten_concat(node_id n, std::vector<node_id>& out) const
+    {
+        const node& current = _M_nodes[n];
+        if (current._M_kind == node_kind::eEpsilon)
+            return;
+        if (current._M_kind != node_kind::eConcat)
+        {
+            out.push_back(n);
+            return;
+        }
+        flatten_concat(current._M_lhs, out);
+        flatten_concat(current._M_rhs, out);
+    }
+
+    regex_optimizer::node_id regex_optimizer::make_concat(const std::vector<node_id>& factors)
+    {
+        std::vector<node_id> flat;
+        for(const auto n: factors)
+            flatten_concat(n, flat);
+        if (flat.empty())
+            return make_node(node_kind::eEpsilon);
+        node_id result = flat.front();
+        for(std::size_t i = 1; i < flat.size(); ++i)
+            result = make_node(node_kind::eConcat, 0, result, flat[i]);
+        return result;
+    }
+
+    regex_optimizer::node_id regex_optimizer::make_union(const std::vector<node_id>& alternatives)
+    {
+        std::vector<node_id> flat;
+        for(const auto alternative: alternatives)
+        {
+            std::vector<node_id> branches;
+            flatten_union(alternative, branches);
+            for(const auto branch: branches)
+            {
+                if (std::find(flat.begin(), flat.end(), branch) == flat.end())
+                    flat.push_back(branch);
+            }
+        }
+        node_id result = flat.front();
+        for(std::size_t i = 1; i < flat.size(); ++i)
+            result = make_node(node_kind::eUnion, 0, result, flat[i]);
+        return result;
+    }
+
+    void regex_optimizer::emit(node_id n, std::vector<char>& out) const
+    {
+        const node& current = _M_nodes[n];
+        switch (current._M_kind)
+        {
+            case node_kind::eEpsilon:
+                out.push_back(__epsilon);
+                break;
+            case node_kind::eLiteral:
+                out.push_back(current._M_value);
+                break;
+            case node_kind::eStar:
+                emit(current._M_lhs, out);
+                out.push_back('*');
+                break;
+            case node_kind::eConcat:
+                emit(current._M_lhs, out);
+                emit(current._M_rhs, out);
+                out.push_back('?');
+                break;
+            case node_kind::eUnion:
+                emit(current._M_lhs, out);
+                emit(current._M_rhs, out);
+                out.push_back('|');
+                break;
+        }
+    }
+}
@@ -7,7 +7,150 @@
 
 namespace alegna::lexer::regex
 {
-    regex_parser::regex_parser(std::istream& is)
+    namespace
+    {
+        //A sequence of byte ranges, one range per byte of a UTF-8 
+        //encoded character.
+        typedef std::vector<std::pair<unsigned char, unsigned char>> byte_sequence;
+
+        //Encodes a code point as UTF-8.
+        std::string encode_utf8(char32_t c)
+        {
+            std::string out;
+            if (c < 0x80)
+                out += static_cast<char>(c);
+            else if (c < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (c >> 6));
+                out += static_cast<char>(0x80 | (c & 0x3F));
+            }
+            else if (c < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (c >> 12));
+                out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (c & 0x3F));
+            }
+            else 
+            {
+                out += static_cast<char>(0xF0 | (c >> 18));
+                out += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (c & 0x3F));
+            }
+            return out;
+        }
+
+        //Splits the code points in [lo, hi] into byte sequences where 
+        //every byte can vary independently of the others. lo and hi 
+        //must have UTF-8 encodings of the same length.
+        void split_utf8_range(char32_t lo, char32_t hi, std::vector<byte_sequence>& out)
+        {
+            std::string lo_bytes = encode_utf8(lo);
+            std::string hi_bytes = encode_utf8(hi);
+            for(size_t i = 1; i < lo_bytes.size(); ++i)
+            {
+                //Mask of the bits stored in the last i bytes
+                char32_t m = (char32_t(1) << (6 * i)) - 1;
+                if ((lo & ~m) != (hi & ~m))
+                {
+                    if ((lo & m) != 0)
+                    {
+                        split_utf8_range(lo, lo | m, out);
+                        split_utf8_range((lo | m) + 1, hi, out);
+                        return;
+                    }
+                    if ((hi & m) != m)
+                    {
+                        split_utf8_range(lo, (hi & ~m) - 1, out);
+                        split_utf8_range(hi & ~m, hi, out);
+                        return;
+                    }
+                }
+            }
+            byte_sequence seq;
+            for(size_t i = 0; i < lo_bytes.size(); ++i)
+                seq.emplace_back(lo_bytes[i], hi_bytes[i]);
+            out.push_back(seq);
+        }
+
+        //Reads a code point written as \u{hex digits} starting at pos 
+        //and moves pos past it.
+        char32_t read_code_point(const std::string& str, size_t& pos)
+        {
+            if (str.compare(pos, 3, "\\u{") != 0)
+                throw alegna::exceptions::invalid_regex_exception();
+            pos += 3;
+            char32_t c = 0;
+            size_t digits = 0;
+            for(; pos < str.size() && isxdigit(static_cast<unsigned char>(str[pos])); ++pos, ++digits)
+            {
+                char d = static_cast<char>(tolower(static_cast<unsigned char>(str[pos])));
+                c = c * 16 + (isdigit(static_cast<unsigned char>(d)) ? d - '0' : d - 'a' + 10);
+            }
+            if (digits == 0 || digits > 6 || pos >= str.size() || str[pos] != '}')
+                throw alegna::exceptions::invalid_regex_exception();
+            ++pos;
+            return c;
+        }
+    }
+
+    std::string utf8_class(char32_t lo, char32_t hi)
+    {
+        if (lo > hi || hi > 0x10FFFF)
+            throw alegna::exceptions::invalid_regex_exception();
+        //The regex syntax has no escapes, so code points that are also 
+        //operators (or the epsilon marker \0) cannot be matched
+        for(const char op: {'\0', '(', ')', '|', '*', '?'})
+        {
+            if (lo <= static_cast<char32_t>(op) && static_cast<char32_t>(op) <= hi)
+                throw alegna::exceptions::invalid_regex_exception();
+        }
+
+        //Ranges of code points with the same encoded length. 
+        //Surrogates are left out.
+        const std::pair<char32_t, char32_t> lengths[] = {
+            {0x0, 0x7F}, {0x80, 0x7FF}, {0x800, 0xD7FF}, {0xE000, 0xFFFF}, {0x10000, 0x10FFFF}
+        };
+        std::vector<byte_sequence> sequences;
+        for(const auto& length: lengths)
+        {
+            char32_t first = std::max(lo, length.first);
+            char32_t last = std::min(hi, length.second);
+            if (first <= last)
+                split_utf8_range(first, last, sequences);
+        }
+        if (sequences.empty())
+            throw alegna::exceptions::invalid_regex_exception();
+
+        std::string out = "(";
+        for(size_t i = 0; i < sequences.size(); ++i)
+        {
+            if (i != 0)
+                out += '|';
+            for(const auto& range: sequences[i])
+            {
+                if (range.first == range.second)
+                {
+                    out += static_cast<char>(range.first);
+                    continue;
+                }
+                out += '(';
+                for(unsigned int b = range.first; b <= range.second; ++b)
+                {
+                    if (b != range.first)
+                        out += '|';
+                    out += static_cast<char>(b);
+                }
+                out += ')';
+            }
+        }
+        out += ')';
+        return out;
+    }
+
+    bool is_operator(char c);
+
+    regex_parser::regex_parser(std::istream& is) noexcept
         : _M_in(is)
     {
         
@@ -15,27 +158,47 @@ namespace alegna::lexer::regex
 
     std::optional<std::vector<char>> regex_parser::parse_regex()
     {
-        if(!_M_in)
+        std::string regex;
+        if(!_M_in || !std::getline(_M_in, regex))
             return std::optional<std::vector<char>>();
         std::deque<char> op_stack;
         std::vector<char> out;
-        std::string regex;
-        std::getline(_M_in, regex);
+        //Number of operands written to out and not yet used by an 
+        //operator, so that operators with missing operands are caught
+        size_t operands = 0;
+        auto write = [&](char c) {
+            if (c == '*')
+            {
+                if (operands < 1)
+                    throw alegna::exceptions::invalid_regex_exception();
+            }
+            else if (c == '?' || c == '|')
+            {
+                if (operands < 2)
+                    throw alegna::exceptions::invalid_regex_exception();
+                --operands;
+            }
+            else 
+                ++operands;
+            out.push_back(c);
+        };
         preprocess(regex);
         for(const auto c: regex)
         {
             int priority = get_priority(c);
             if (priority == -1)
-                out.push_back(c);
-            else if (priority == 3)
+                write(c);
+            else if (priority == 4)
                 op_stack.push_front(c);
-            else if (priority == 1)
+            else if (priority == 3)
+                //* is a postfix operator that binds tightest, it can be 
+                //written out immediately
+                write(c);
+            else if (priority == 0)
             {
-                if (op_stack.empty())
-                    throw alegna::exceptions::invalid_regex_exception();
-                while (op_stack.front() != ')' && !op_stack.empty())
+                while (!op_stack.empty() && op_stack.front() != '(')
                 {
-                    out.push_back(op_stack.front());
+                    write(op_stack.front());
                     op_stack.pop_front();
                 }
                 if (op_stack.empty())
@@ -44,9 +207,9 @@ namespace alegna::lexer::regex
             }
             else 
             {
-                while(!op_stack.empty() && get_priority(op_stack.front()) > priority)
+                while(!op_stack.empty() && op_stack.front() != '(' && get_priority(op_stack.front()) >= priority)
                 {
-                    out.push_back(op_stack.front());
+                    write(op_stack.front());
                     op_stack.pop_front();
                 }
                 op_stack.push_front(c);
@@ -55,9 +218,14 @@ namespace alegna::lexer::regex
 
         while(!op_stack.empty())
         {
-            out.push_back(op_stack.front());
+            if (op_stack.front() == '(')
+                throw alegna::exceptions::invalid_regex_exception();
+            write(op_stack.front());
             op_stack.pop_front();
         }
+        //A valid regex reduces to exactly one operand
+        if (operands != 1)
+            throw alegna::exceptions::invalid_regex_exception();
         return std::optional<std::vector<char>>(out);
     }
 
@@ -70,10 +238,56 @@ namespace alegna::lexer::regex
             if (ex)
                 regex.push_back(*ex);
         }
+        return regex;
+    }
+
+    void regex_parser::expand_unicode_classes(std::string& regex)
+    {
+        std::string result;
+        size_t pos = 0;
+        while (pos < regex.size())
+        {
+            if (regex.compare(pos, 4, "[\\u{") != 0)
+            {
+                result += regex[pos++];
+                continue;
+            }
+            //Skip [
+            ++pos;
+            std::vector<std::string> alternatives;
+            while (pos >= regex.size() || regex[pos] != ']')
+            {
+                char32_t lo = read_code_point(regex, pos);
+                char32_t hi = lo;
+                if (pos < regex.size() && regex[pos] == '-')
+                    hi = read_code_point(regex, ++pos);
+                alternatives.push_back(utf8_class(lo, hi));
+            }
+            //Skip ]
+            ++pos;
+            if (alternatives.size() == 1)
+            {
+                result += alternatives.front();
+                continue;
+            }
+            result += '(';
+            for(size_t i = 0; i < alternatives.size(); ++i)
+            {
+                if (i != 0)
+                    result += '|';
+                result += alternatives[i];
+            }
+            result += ')';
+        }
+        regex = result;
     }
 
     void regex_parser::preprocess(std::string& regex)
     {
+        //Expand Unicode classes into UTF-8 byte sequences first, the 
+        //DFA works on bytes and never decodes its input
+        expand_unicode_classes(regex);
+
         //Strings to hold the preprocessed regex
         std::string result_num;
         std::string result_lower;
@@ -98,22 +312,22 @@ namespace alegna::lexer::regex
         //Replace [a-z]
         std::regex_replace(back_inserter(result_lower), result_num.begin(), result_num.end(), lower_re, lower_replacement);
         //Replace [A-Z]
-        std::regex_replace(back_inserter(result_upper), result_lower.begin(), result_upper.begin(), upper_re, upper_replacement);
+        std::regex_replace(back_inserter(result_upper), result_lower.begin(), result_lower.end(), upper_re, upper_replacement);
         //Replace [A-Za-z]
         std::regex_replace(back_inserter(final_result), result_upper.begin(), result_upper.end(), all_re, all_replacement);
 
-        //Insert concatenation operators
-        for(size_t i = 0; i < final_result.size() - 1; ++i)
+        //Insert concatenation operators between a character, ) or * 
+        //and a following character or (
+        regex.clear();
+        for(size_t i = 0; i < final_result.size(); ++i)
         {
-            if(!is_operator(final_result[i]))
-            {
-                if(final_result[i] != '(' && final_result[i+1] != ')')
-                    final_result.insert(i++, "?");
-            }
-            else if(final_result[i] == ')' && !is_operator(final_result[i]))
-                final_result.insert(i++, "?");
-            else if (final_result[i] == '*')
-                final_result.insert(i++, "?");
+            regex += final_result[i];
+            if (i + 1 == final_result.size())
+                break;
+            char curr = final_result[i];
+            char next = final_result[i + 1];
+            if (curr != '(' && curr != '|' && next != ')' && !is_operator(next))
+                regex += '?';
         }
     }
 
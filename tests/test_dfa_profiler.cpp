@@ -0,0 +1,64 @@
+#include "test_framework.h"
+#include "lexer/dfa_profiler.h"
+#include <vector>
+#include <string>
+
+using namespace alegna::lexer::automata;
+
+SET_UP_TESTS()
+
+//0 -a-> 1 -a-> 1, 0 -b-> 2 -c-> 3, 0 -z-> 4 -y-> 5
+automatum<char> make_dfa()
+{
+    automatum<char>::fa_table_t table(6);
+    table[0] = {{'a', 1}, {'b', 2}, {'z', 4}};
+    table[1] = {{'a', 1}};
+    table[2] = {{'c', 3}};
+    table[4] = {{'y', 5}};
+    return automatum<char>(table, {1, 3, 5});
+}
+
+MAKE_TEST(dfa_profiler_1, Tests if hot states and their successors are numbered first)
+    auto dfa = make_dfa();
+    std::string corpus = "bcbcbcbcaaab";
+
+    dfa_profiler<char> profiler(dfa);
+    profiler.profile(corpus.begin(), corpus.end());
+    std::vector<state_t> expected = {0, 3, 1, 2, 4, 5};
+    auto actual = profiler.hot_order();
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(dfa_profiler_2, Tests if renumbering states preserves the automatum)
+    auto dfa = make_dfa();
+    std::string corpus = "bcbcbcbcaaab";
+
+    dfa_profiler<char> profiler(dfa);
+    profiler.profile(corpus.begin(), corpus.end());
+    auto new_numbers = profiler.hot_order();
+    auto reordered = renumber_states(dfa, new_numbers);
+    std::vector<std::string> inputs = {"a", "aa", "bc", "zy", "b", "z", "ac"};
+    for (const auto& input: inputs)
+    {
+        state_t s = 0;
+        state_t r = 0;
+        for (const auto c: input)
+        {
+            s = dfa.delta(s, c);
+            r = reordered.delta(r, c);
+        }
+        std::vector<bool> expected = {s == automatum<char>::ERROR ? true : new_numbers[s] == r, dfa.is_accepting_state(s)};
+        std::vector<bool> actual = {true, reordered.is_accepting_state(r)};
+        CONTENTS_TEST(expected, actual);
+    }
+    PASSED()
+END_TEST()
+
+int main(int argc, char** argv)
+{
+    test_dfa_profiler_1();
+    test_dfa_profiler_2();
+    TEST_SUMMARY()
+    return num_failed == 0 ? 0 : 1;
+}
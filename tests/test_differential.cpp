@@ -0,0 +1,411 @@
+#include "test_framework.h"
+#include "lexer/nfa_simulator.h"
+#include "lexer/dfa_profiler.h"
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+using namespace alegna::lexer::automata;
+
+SET_UP_TESTS()
+
+//File with the lowest acceptable speedup of every engine over another
+std::string baseline_path;
+//If true, the baseline file is rewritten from the measured speedups
+bool update_baseline = false;
+//Fraction of a measured speedup written to the baseline, so timing
+//noise does not fail the test
+constexpr double BASELINE_SLACK = 0.8;
+
+//A token found by one of the engines. Text that no rule matches
+//becomes tokens of kind -1 and length 1.
+struct lexed_token
+{
+    std::size_t _M_offset;
+    std::size_t _M_length;
+    int _M_kind;
+
+    bool operator==(const lexed_token& rhs) const
+    {
+        return _M_offset == rhs._M_offset && _M_length == rhs._M_length && _M_kind == rhs._M_kind;
+    }
+
+    bool operator!=(const lexed_token& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const lexed_token& t)
+    {
+        return os << "{" << t._M_offset << ", " << t._M_length << ", " << t._M_kind << "}";
+    }
+};
+
+//A randomly generated lexer specification. Every accepting state of
+//the NFA has a token kind, lower kinds win when several rules match.
+struct lexer_spec
+{
+    nfa_automatum<char> _M_nfa;
+    std::vector<int> _M_kinds;
+    std::string _M_input;
+};
+
+//A DFA compiled from a lexer_spec, with the token kind of each state
+//(-1 for states that are not accepting).
+struct compiled_spec
+{
+    automatum<char> _M_dfa;
+    std::vector<int> _M_kinds;
+};
+
+//Returns a random number of edges: usually none, sometimes several.
+std::size_t random_edge_count(std::mt19937& gen)
+{
+    unsigned int roll = gen() % 20;
+    if (roll < 11)
+        return 0;
+    if (roll < 16)
+        return 1;
+    if (roll < 19)
+        return 2;
+    return 3;
+}
+
+//Generates a random NFA over an alphabet that includes the NUL byte.
+//States can have several epsilon transitions and several transitions on
+//the same byte, and every spec has at least one of each.
+//@param alphabet the bytes the NFA has transitions on
+//@param input_alphabet the bytes of the input
+//@param max_states the largest number of states of the NFA
+lexer_spec random_spec(std::mt19937& gen, const std::string& alphabet, const std::string& input_alphabet,
+                       std::size_t max_states)
+{
+    std::size_t num_states = 4 + gen() % (max_states - 3);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+
+    nfa_automatum<char>::nfa_table_t table(num_states);
+    nfa_automatum<char>::epsilon_table_t epsilon(num_states);
+    std::unordered_set<state_t> accepting_states;
+    std::vector<int> kinds(num_states, -1);
+    for (std::size_t s = 0; s < num_states; ++s)
+    {
+        for (const auto c: alphabet)
+        {
+            for (std::size_t n = random_edge_count(gen); n > 0; --n)
+                table[s][c].push_back(static_cast<state_t>(gen() % num_states));
+        }
+        for (std::size_t n = random_edge_count(gen); n > 0; --n)
+            epsilon[s].push_back(static_cast<state_t>(gen() % num_states));
+        if (s != 0 && chance(gen) < 0.25)
+        {
+            accepting_states.insert(static_cast<state_t>(s));
+            kinds[s] = static_cast<int>(gen() % 4);
+        }
+    }
+    //Guarantee a state with two epsilon transitions and a state with 
+    //two transitions on the same byte
+    auto& epsilon_state = epsilon[gen() % num_states];
+    while (epsilon_state.size() < 2)
+        epsilon_state.push_back(static_cast<state_t>(gen() % num_states));
+    auto& byte_targets = table[gen() % num_states][alphabet[gen() % alphabet.size()]];
+    while (byte_targets.size() < 2)
+        byte_targets.push_back(static_cast<state_t>(gen() % num_states));
+
+    std::string input(4000, ' ');
+    for (auto& c: input)
+        c = input_alphabet[gen() % input_alphabet.size()];
+    return lexer_spec{nfa_automatum<char>(table, epsilon, accepting_states), kinds, input};
+}
+
+//Generates a spec over a small alphabet. Its DFA is sparse, so it is
+//packed as a comb vector. The input also contains a byte no rule matches.
+lexer_spec narrow_spec(std::mt19937& gen)
+{
+    return random_spec(gen, std::string("abc\0", 4), std::string("abc\0e", 5), 31);
+}
+
+//Generates a spec over every byte. Its DFA has transitions on most
+//bytes, so it is packed as a full table.
+lexer_spec wide_spec(std::mt19937& gen)
+{
+    std::string bytes(256, '\0');
+    for (std::size_t b = 0; b < bytes.size(); ++b)
+        bytes[b] = static_cast<char>(b);
+    return random_spec(gen, bytes, bytes, 8);
+}
+
+//Splits input into tokens, always taking the longest match.
+//@param match returns the length of the longest token starting at
+//             a position (0 if there is none) and sets its kind
+template<typename _MatchFn>
+std::vector<lexed_token> tokenize(const std::string& input, _MatchFn match)
+{
+    std::vector<lexed_token> tokens;
+    std::size_t pos = 0;
+    while (pos < input.size())
+    {
+        int kind = -1;
+        std::size_t length = match(pos, kind);
+        if (length == 0)
+        {
+            kind = -1;
+            length = 1;
+        }
+        tokens.push_back(lexed_token{pos, length, kind});
+        pos += length;
+    }
+    return tokens;
+}
+
+//Returns the token kind of a set of NFA states, or -1 if none accept.
+int kind_of(const std::vector<state_t>& states, const std::vector<int>& kinds)
+{
+    int kind = -1;
+    for (const auto s: states)
+    {
+        if (kinds[s] != -1 && (kind == -1 || kinds[s] < kind))
+            kind = kinds[s];
+    }
+    return kind;
+}
+
+//Lexes a spec's input by simulating its NFA.
+std::vector<lexed_token> lex_nfa(const lexer_spec& spec)
+{
+    nfa_simulator<char> simulator(spec._M_nfa);
+    const std::string& input = spec._M_input;
+    return tokenize(input, [&](std::size_t pos, int& kind) {
+        std::size_t length = 0;
+        auto states = simulator.start();
+        for (std::size_t i = pos; i < input.size() && !states.empty(); ++i)
+        {
+            states = simulator.delta(states, input[i]);
+            int k = kind_of(states, spec._M_kinds);
+            if (k != -1)
+            {
+                kind = k;
+                length = i - pos + 1;
+            }
+        }
+        return length;
+    });
+}
+
+//Lexes an input with a compiled DFA. Tokens end in the DFA's accepting
+//states, the kind map only gives their kind.
+std::vector<lexed_token> lex_dfa(const compiled_spec& compiled, const std::string& input)
+{
+    return tokenize(input, [&](std::size_t pos, int& kind) {
+        std::size_t length = 0;
+        state_t s = 0;
+        for (std::size_t i = pos; i < input.size(); ++i)
+        {
+            s = compiled._M_dfa.delta(s, input[i]);
+            if (s == automatum<char>::ERROR)
+                break;
+            if (compiled._M_dfa.is_accepting_state(s))
+            {
+                kind = compiled._M_kinds[s];
+                length = i - pos + 1;
+            }
+        }
+        return length;
+    });
+}
+
+//Compiles a spec's NFA into a DFA with construct_dfa.
+compiled_spec compile(const lexer_spec& spec)
+{
+    std::vector<std::vector<state_t>> nfa_states;
+    auto dfa = construct_dfa(spec._M_nfa, nfa_states);
+    std::vector<int> kinds;
+    for (const auto& states: nfa_states)
+        kinds.push_back(kind_of(states, spec._M_kinds));
+    return compiled_spec{dfa, kinds};
+}
+
+//Copies a compiled DFA without packing it, so its transitions are looked
+//up in the hash map rows.
+compiled_spec unpacked(const compiled_spec& compiled)
+{
+    automatum<char> dfa(compiled._M_dfa.get_table(), compiled._M_dfa.get_accepting_states());
+    return compiled_spec{dfa, compiled._M_kinds};
+}
+
+//Renumbers a compiled DFA's states by how often they are used on the spec's input.
+compiled_spec hot_order(const compiled_spec& compiled, const std::string& input)
+{
+    dfa_profiler<char> profiler(compiled._M_dfa);
+    profiler.profile(input.begin(), input.end());
+    auto new_numbers = profiler.hot_order();
+    std::vector<int> kinds(compiled._M_kinds.size());
+    for (std::size_t s = 0; s < kinds.size(); ++s)
+        kinds[new_numbers[s]] = compiled._M_kinds[s];
+    return compiled_spec{renumber_states(compiled._M_dfa, new_numbers), kinds};
+}
+
+//Runs lex over every input until at least min_seconds have passed.
+//@return the throughput in MB/s
+template<typename _LexFn>
+double measure_throughput(const std::vector<lexer_spec>& specs, _LexFn lex, double min_seconds = 0.25)
+{
+    typedef std::chrono::steady_clock clock;
+    std::size_t bytes = 0;
+    std::size_t num_tokens = 0;
+    auto start = clock::now();
+    std::chrono::duration<double> elapsed(0);
+    while (elapsed.count() < min_seconds)
+    {
+        for (std::size_t i = 0; i < specs.size(); ++i)
+        {
+            num_tokens += lex(i).size();
+            bytes += specs[i]._M_input.size();
+        }
+        elapsed = clock::now() - start;
+    }
+    //Keep the results alive so the work is not optimized away
+    if (num_tokens == 0)
+        std::cout << "No tokens lexed" << std::endl;
+    return bytes / elapsed.count() / 1e6;
+}
+
+//Reads the baseline file, one "speedup value" pair per line.
+//@return false if the file could not be read
+bool read_baseline(const std::string& path, std::map<std::string, double>& baseline)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string speedup;
+        double value;
+        if (line.empty() || line[0] == '#')
+            continue;
+        if (fields >> speedup >> value)
+            baseline[speedup] = value;
+    }
+    return true;
+}
+
+//Writes a baseline file from measured speedups.
+void write_baseline(const std::string& path, const std::map<std::string, double>& measured)
+{
+    std::ofstream out(path);
+    out << "#Lowest acceptable speedup of each engine in test_differential.cpp over another engine," << std::endl;
+    out << "#measured in the same run. Written by Test_Differential --update-baseline." << std::endl;
+    for (const auto& speedup: measured)
+        out << speedup.first << " " << speedup.second * BASELINE_SLACK << std::endl;
+}
+
+MAKE_TEST(differential_1, Tests if NFA simulation and every DFA layout produce the same tokens)
+    std::mt19937 gen(31);
+    std::vector<bool> expected_layouts;
+    std::vector<bool> layouts;
+    for (int i = 0; i < 200; ++i)
+    {
+        //Every fourth spec has a wide alphabet and a dense DFA
+        bool wide = i % 4 == 3;
+        auto spec = wide ? wide_spec(gen) : narrow_spec(gen);
+        auto compiled = compile(spec);
+        auto hash_map = unpacked(compiled);
+        auto reordered = hot_order(compiled, spec._M_input);
+
+        auto expected_layout = wide ? packed_table::layout::eDense : packed_table::layout::eComb;
+        expected_layouts.insert(expected_layouts.end(), {true, true, true});
+        layouts.push_back(compiled._M_dfa.get_packed_table().get_layout() == expected_layout);
+        layouts.push_back(reordered._M_dfa.get_packed_table().get_layout() == expected_layout);
+        layouts.push_back(!hash_map._M_dfa.is_packed());
+
+        auto nfa_tokens = lex_nfa(spec);
+        auto dfa_tokens = lex_dfa(compiled, spec._M_input);
+        auto hash_map_tokens = lex_dfa(hash_map, spec._M_input);
+        auto reordered_tokens = lex_dfa(reordered, spec._M_input);
+        CONTENTS_TEST(nfa_tokens, dfa_tokens);
+        CONTENTS_TEST(nfa_tokens, hash_map_tokens);
+        CONTENTS_TEST(nfa_tokens, reordered_tokens);
+    }
+    CONTENTS_TEST(expected_layouts, layouts);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(differential_2, Tests if every engine is at least as much faster than another as its baseline)
+    std::mt19937 gen(32);
+    std::vector<lexer_spec> specs;
+    std::vector<compiled_spec> compiled;
+    std::vector<compiled_spec> hash_map;
+    std::vector<compiled_spec> reordered;
+    for (int i = 0; i < 50; ++i)
+    {
+        specs.push_back(narrow_spec(gen));
+        compiled.push_back(compile(specs.back()));
+        hash_map.push_back(unpacked(compiled.back()));
+        reordered.push_back(hot_order(compiled.back(), specs.back()._M_input));
+    }
+
+    //Absolute throughput depends on the machine and the build type, so
+    //only speedups between engines measured in this run are compared.
+    //The engines take turns over several short rounds and keep their best
+    //round, so a burst of load on the machine does not slow down only one.
+    std::map<std::string, double> best;
+    for (int round = 0; round < 5; ++round)
+    {
+        std::map<std::string, double> throughput;
+        throughput["nfa_simulation"] = measure_throughput(specs, [&](std::size_t i) {
+            return lex_nfa(specs[i]);
+        }, 0.05);
+        throughput["dfa"] = measure_throughput(specs, [&](std::size_t i) {
+            return lex_dfa(compiled[i], specs[i]._M_input);
+        }, 0.05);
+        throughput["dfa_hash_map"] = measure_throughput(specs, [&](std::size_t i) {
+            return lex_dfa(hash_map[i], specs[i]._M_input);
+        }, 0.05);
+        throughput["dfa_hot_order"] = measure_throughput(specs, [&](std::size_t i) {
+            return lex_dfa(reordered[i], specs[i]._M_input);
+        }, 0.05);
+        for (const auto& engine: throughput)
+            best[engine.first] = std::max(best[engine.first], engine.second);
+    }
+    std::map<std::string, double> measured;
+    measured["dfa/nfa_simulation"] = best["dfa"] / best["nfa_simulation"];
+    measured["dfa/dfa_hash_map"] = best["dfa"] / best["dfa_hash_map"];
+    measured["dfa_hot_order/dfa"] = best["dfa_hot_order"] / best["dfa"];
+
+    if (update_baseline)
+    {
+        write_baseline(baseline_path, measured);
+        std::cout << "Wrote baseline " << baseline_path << std::endl;
+    }
+    std::map<std::string, double> baseline;
+    if (!read_baseline(baseline_path, baseline))
+    {
+        FAILED("Could not read baseline file \"" << baseline_path << "\"")
+    }
+    for (const auto& speedup: measured)
+    {
+        auto it = baseline.find(speedup.first);
+        if (it == baseline.end())
+        {
+            FAILED("No baseline for " << speedup.first)
+        }
+        SPEEDUP_TEST(speedup.first, speedup.second, it->second);
+    }
+    PASSED()
+END_TEST()
+
+//Usage: Test_Differential [baseline file] [--update-baseline]
+int main(int argc, char** argv)
+{
+    if (argc > 1)
+        baseline_path = argv[1];
+    update_baseline = argc > 2 && std::string(argv[2]) == "--update-baseline";
+    test_differential_1();
+    test_differential_2();
+    TEST_SUMMARY()
+    return num_failed == 0 ? 0 : 1;
+}
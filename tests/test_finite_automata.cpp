@@ -0,0 +1,125 @@
+#include "test_framework.h"
+#include "lexer/finite_automata.h"
+#include <vector>
+#include <random>
+
+using namespace alegna::lexer::automata;
+
+SET_UP_TESTS()
+
+//Creates a random transition table where each state has about 
+//transitions_per_state transitions.
+automatum<char>::fa_table_t random_table(std::size_t num_states, std::size_t transitions_per_state, unsigned int seed)
+{
+    std::mt19937 gen(seed);
+    automatum<char>::fa_table_t table(num_states);
+    for (auto& row: table)
+    {
+        for (std::size_t i = 0; i < transitions_per_state; ++i)
+            row[static_cast<char>(gen() % 256)] = static_cast<state_t>(gen() % num_states);
+    }
+    return table;
+}
+
+//Looks up every transition of a table in the table's automatum and 
+//returns the states that do not match.
+std::vector<state_t> mismatched_states(const automatum<char>::fa_table_t& table, const automatum<char>& fa)
+{
+    std::vector<state_t> mismatched;
+    for (std::size_t s = 0; s < table.size(); ++s)
+    {
+        for (int b = 0; b < 256; ++b)
+        {
+            auto it = table[s].find(static_cast<char>(b));
+            state_t expected = it == table[s].end() ? automatum<char>::ERROR : it->second;
+            if (fa.delta(static_cast<state_t>(s), static_cast<char>(b)) != expected)
+            {
+                mismatched.push_back(static_cast<state_t>(s));
+                break;
+            }
+        }
+    }
+    return mismatched;
+}
+
+MAKE_TEST(finite_automata_1, Tests if dense tables are packed without changing transitions)
+    auto table = random_table(50, 200, 1);
+    automatum<char> fa(table, {});
+    fa.pack();
+    std::vector<bool> expected = {true};
+    std::vector<bool> actual = {fa.get_packed_table().get_layout() == packed_table::layout::eDense};
+    CONTENTS_TEST(expected, actual);
+    std::vector<state_t> no_states;
+    auto mismatched = mismatched_states(table, fa);
+    CONTENTS_TEST(no_states, mismatched);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(finite_automata_2, Tests if large sparse tables are compressed without changing transitions)
+    auto table = random_table(40000, 4, 2);
+    automatum<char> fa(table, {});
+    fa.pack();
+    std::vector<bool> expected = {true, true};
+    std::vector<bool> actual = {
+        fa.get_packed_table().get_layout() == packed_table::layout::eComb,
+        fa.get_packed_table().size_bytes() < table.size() * 256 * sizeof(state_t) / 8
+    };
+    CONTENTS_TEST(expected, actual);
+    std::vector<state_t> no_states;
+    auto mismatched = mismatched_states(table, fa);
+    CONTENTS_TEST(no_states, mismatched);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(finite_automata_3, Tests if automata are only packed on request)
+    auto table = random_table(20, 4, 3);
+    automatum<char> fa(table, {});
+    std::vector<bool> expected = {false};
+    std::vector<bool> actual = {fa.is_packed()};
+    CONTENTS_TEST(expected, actual);
+    std::vector<state_t> no_states;
+    auto mismatched = mismatched_states(table, fa);
+    CONTENTS_TEST(no_states, mismatched);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(finite_automata_4, Tests if comb rows stay in state order so neighbouring states are close)
+    //Rows of different sizes, so that placing rows by size would
+    //scatter neighbouring states
+    auto table = random_table(40000, 8, 4);
+    for (std::size_t s = 0; s < table.size(); ++s)
+    {
+        while (table[s].size() > 1 + s % 8)
+            table[s].erase(table[s].begin());
+    }
+    automatum<char> fa(table, {});
+    fa.pack();
+    //The first 64 states, where dfa_profiler::hot_order puts the hottest
+    //states, should fit in a few kilobytes instead of being spread out
+    //over the whole table
+    const auto& packed = fa.get_packed_table();
+    std::size_t lowest = packed.row_offset(0);
+    std::size_t highest = packed.row_offset(0);
+    for (state_t s = 1; s < 64; ++s)
+    {
+        lowest = std::min(lowest, packed.row_offset(s));
+        highest = std::max(highest, packed.row_offset(s));
+    }
+    std::vector<bool> expected = {true, true};
+    std::vector<bool> actual = {
+        packed.get_layout() == packed_table::layout::eComb,
+        highest - lowest < 1024
+    };
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+int main(int argc, char** argv)
+{
+    test_finite_automata_1();
+    test_finite_automata_2();
+    test_finite_automata_3();
+    test_finite_automata_4();
+    TEST_SUMMARY()
+    return num_failed == 0 ? 0 : 1;
+}
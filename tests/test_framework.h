@@ -50,6 +50,31 @@
         }\
     }\
 
+//Compares a measured speedup of one engine over another against its 
+//baseline. If the measured speedup is lower, prints an error message 
+//and terminates the test.
+//@param name a description of what was measured
+//@param actual the measured speedup
+//@param baseline the lowest acceptable speedup
+#define SPEEDUP_TEST(name, actual, baseline)\
+    std::cout << name << ": " << actual << "x, baseline: " << baseline << "x" << std::endl;\
+    if (actual < baseline)\
+    {\
+        std::cout << "Test " << test_name << " FAILED! " << name << " speedup " << actual <<\
+        "x is below baseline " << baseline << "x" << std::endl;\
+        test_statuses[test_name] = "FAILED";\
+        ++num_failed;\
+        return;\
+    }
+
+//Prints an error message and terminates the test.
+//@param message a description of why the test failed
+#define FAILED(message)\
+    std::cout << "Test " << test_name << " FAILED! " << message << std::endl;\
+    test_statuses[test_name] = "FAILED";\
+    ++num_failed;\
+    return;
+
 //Prints a message if the test passes.
 #define PASSED()\
     std::cout << "Test " << test_name << " PASSED!" << std::endl;\
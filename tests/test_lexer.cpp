@@ -0,0 +1,157 @@
+#include "test_framework.h"
+#include "lexer/lexer.h"
+#include <vector>
+#include <string>
+
+using alegna::lexer::lexer;
+using alegna::lexer::automata::automatum;
+
+SET_UP_TESTS()
+
+//Returns the line and column of every offset as {line, col, line, col, ...}.
+std::vector<unsigned int> locate_all(const lexer& lex, const std::vector<unsigned int>& offsets)
+{
+    std::vector<unsigned int> locations;
+    for (const auto offset: offsets)
+    {
+        auto location = lex.locate(offset);
+        locations.push_back(location._M_line);
+        locations.push_back(location._M_col);
+    }
+    return locations;
+}
+
+//A lexer with a DFA that accepts nothing, only used to locate offsets.
+lexer make_lexer(const std::string& src)
+{
+    automatum<char> dfa({{}}, {});
+    return lexer(dfa, {}, src);
+}
+
+MAKE_TEST(lexer_1, Tests if offsets on the first and last lines are located)
+    auto lex = make_lexer("int a\nfloat b\nc\n");
+    std::vector<unsigned int> expected = {0, 0, 0, 4, 0, 5, 1, 0, 1, 6, 2, 0, 2, 1, 3, 0};
+    auto actual = locate_all(lex, {0, 4, 5, 6, 12, 14, 15, 16});
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(lexer_2, Tests if offsets are located in CRLF input)
+    auto lex = make_lexer("a\r\nbc\r\n");
+    std::vector<unsigned int> expected = {0, 0, 0, 1, 0, 2, 1, 0, 1, 1, 1, 3, 2, 0};
+    auto actual = locate_all(lex, {0, 1, 2, 3, 4, 6, 7});
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(lexer_3, Tests if offsets are located in an empty source)
+    auto lex = make_lexer("");
+    std::vector<unsigned int> expected = {0, 0};
+    auto actual = locate_all(lex, {0});
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(lexer_4, Tests if offsets are located in a source without a trailing newline)
+    auto lex = make_lexer("ab\ncd");
+    std::vector<unsigned int> expected = {0, 2, 1, 0, 1, 1, 1, 2};
+    auto actual = locate_all(lex, {2, 3, 4, 5});
+    CONTENTS_TEST(expected, actual);
+
+    //Moving a new source in rebuilds the line index
+    lex.set_src(std::string("x\ny\nz"));
+    expected = {2, 0};
+    actual = locate_all(lex, {4});
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+//Returns the token type the lexer's DFA ends in after reading each input.
+std::vector<int> final_tok_types(const lexer& lex, const std::vector<std::string>& inputs)
+{
+    std::vector<int> types;
+    for (const auto& input: inputs)
+    {
+        alegna::lexer::automata::state_t s = 0;
+        for (const auto c: input)
+            s = lex.get_dfa().delta(s, c);
+        auto it = lex.get_tok_types().find(s);
+        types.push_back(it == lex.get_tok_types().end() ? -1 : static_cast<int>(it->second));
+    }
+    return types;
+}
+
+MAKE_TEST(lexer_5, Tests if reordering states keeps token types on the right states)
+    //0 -digit-> 1 -digit-> 1, 0 -+-> 2, 0 -x-> 3 -=-> 4
+    automatum<char>::fa_table_t table(5);
+    table[0] = {{'1', 1}, {'2', 1}, {'+', 2}, {'x', 3}};
+    table[1] = {{'1', 1}, {'2', 1}};
+    table[3] = {{'=', 4}};
+    automatum<char> dfa(table, {1, 2, 3, 4});
+    std::unordered_map<alegna::lexer::automata::state_t, lexer::tok_type> tok_types = {
+        {1, lexer::tok_type::eInt}, {2, lexer::tok_type::ePlus},
+        {3, lexer::tok_type::eIdentifier}, {4, lexer::tok_type::eEq}
+    };
+    lexer lex(dfa, tok_types);
+    std::vector<std::string> inputs = {"12", "+", "x", "x=", "1+", ""};
+    auto expected = final_tok_types(lex, inputs);
+
+    lex.reorder_states("x=x=x=x=x=12+12+1");
+    auto actual = final_tok_types(lex, inputs);
+    CONTENTS_TEST(expected, actual);
+
+    //x and x= are the hottest, so they should have moved
+    std::vector<bool> moved = {lex.get_tok_types().find(3) == lex.get_tok_types().end() ||
+                               lex.get_tok_types().at(3) != lexer::tok_type::eIdentifier};
+    std::vector<bool> expected_moved = {true};
+    CONTENTS_TEST(expected_moved, moved);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(lexer_6, Tests if tokens start at their first character)
+    //0 -digit-> 1, 0 -+-> 2, 0 -a-> 3 -b-> 4. ab is an eVar because eIdentifier
+    //has the same value as eFloat, which make_token parses as a number.
+    automatum<char>::fa_table_t table(5);
+    table[0] = {{'1', 1}, {'2', 1}, {'+', 2}, {'a', 3}};
+    table[3] = {{'b', 4}};
+    automatum<char> dfa(table, {1, 2, 4});
+    std::unordered_map<alegna::lexer::automata::state_t, lexer::tok_type> tok_types = {
+        {1, lexer::tok_type::eInt}, {2, lexer::tok_type::ePlus}, {4, lexer::tok_type::eVar}
+    };
+    lexer lex(dfa, tok_types, "  1 + ab\n+2");
+    auto tokens = lex.lex();
+
+    std::vector<unsigned int> offsets;
+    std::vector<int> types;
+    for (const auto& tok: tokens)
+    {
+        offsets.push_back(tok._M_offset);
+        types.push_back(static_cast<int>(tok._M_type));
+    }
+    std::vector<unsigned int> expected_offsets = {2, 4, 6, 9, 10, 11};
+    std::vector<int> expected_types = {
+        static_cast<int>(lexer::tok_type::eInt), static_cast<int>(lexer::tok_type::ePlus),
+        static_cast<int>(lexer::tok_type::eVar), static_cast<int>(lexer::tok_type::ePlus),
+        static_cast<int>(lexer::tok_type::eInt), static_cast<int>(lexer::tok_type::eEOF)
+    };
+    CONTENTS_TEST(expected_offsets, offsets);
+    CONTENTS_TEST(expected_types, types);
+
+    //ab is on the first line, the second + starts the second line
+    std::vector<unsigned int> expected = {0, 6, 1, 0};
+    auto actual = locate_all(lex, {tokens[2]._M_offset, tokens[3]._M_offset});
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+int main(int argc, char** argv)
+{
+    test_lexer_1();
+    test_lexer_2();
+    test_lexer_3();
+    test_lexer_4();
+    test_lexer_5();
+    test_lexer_6();
+    TEST_SUMMARY()
+    return num_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+#include "test_framework.h"
+#include "lexer/regex_optimizer.h"
+#include <vector>
+
+SET_UP_TESTS()
+
+MAKE_TEST(regex_optimizer_1, Tests if optimizer factors common prefixes out of keyword lists)
+    //for|foreach|format
+    std::vector<char> keywords = {'f', 'o', '?', 'r', '?',
+                                  'f', 'o', '?', 'r', '?', 'e', '?', 'a', '?', 'c', '?', 'h', '?', '|',
+                                  'f', 'o', '?', 'r', '?', 'm', '?', 'a', '?', 't', '?', '|'};
+    //for(\0|each|mat)
+    std::vector<char> expected = {'f', 'o', '?', 'r', '?',
+                                  '\0', 'e', 'a', '?', 'c', '?', 'h', '?', '|', 'm', 'a', '?', 't', '?', '|', '?'};
+
+    alegna::lexer::regex::regex_optimizer ro;
+    auto optimized = ro.optimize_regex(keywords);
+    CONTENTS_TEST(expected, optimized);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(regex_optimizer_2, Tests if optimizer factors common suffixes and removes duplicates)
+    //+=|-=|+=
+    std::vector<char> operators = {'+', '=', '?', '-', '=', '?', '|', '+', '=', '?', '|'};
+    //(+|-)=
+    std::vector<char> expected = {'+', '-', '|', '=', '?'};
+
+    alegna::lexer::regex::regex_optimizer ro;
+    auto optimized = ro.optimize_regex(operators);
+    CONTENTS_TEST(expected, optimized);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(regex_optimizer_3, Tests if optimizer leaves expressions without alternation unchanged)
+    //ab*
+    std::vector<char> simple_regex = {'a', 'b', '*', '?'};
+
+    alegna::lexer::regex::regex_optimizer ro;
+    auto optimized = ro.optimize({simple_regex, simple_regex});
+    CONTENTS_TEST(simple_regex, optimized[0]);
+    CONTENTS_TEST(simple_regex, optimized[1]);
+    PASSED()
+END_TEST()
+
+int main(int argc, char** argv)
+{
+    test_regex_optimizer_1();
+    test_regex_optimizer_2();
+    test_regex_optimizer_3();
+    TEST_SUMMARY()
+    return num_failed == 0 ? 0 : 1;
+}
@@ -1,5 +1,6 @@
 #include "test_framework.h"
 #include "lexer/regex_parser.h"
+#include "exceptions/exceptions.h"
 #include <vector>
 #include <sstream>
 
@@ -17,8 +18,62 @@ MAKE_TEST(regex_parser_1, Tests if parser can parse simple regex)
     PASSED()
 END_TEST()
 
+MAKE_TEST(regex_parser_2, Tests if Unicode ranges are converted to UTF-8 byte sequences)
+    std::vector<std::string> expected = {"(\xC3(\xA9|\xAA))", "(\x7F|\xC2\x80)", "(\xE2\x82\xAC)"};
+    std::vector<std::string> actual = {
+        alegna::lexer::regex::utf8_class(0xE9, 0xEA),
+        alegna::lexer::regex::utf8_class(0x7F, 0x80),
+        alegna::lexer::regex::utf8_class(0x20AC, 0x20AC)
+    };
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(regex_parser_3, Tests if Unicode classes are parsed into UTF-8 byte sequences)
+    //U+E9 to U+EA followed by any number of x
+    std::string unicode_regex = "[\\u{E9}-\\u{EA}]x*";
+    std::vector<char> expected = {'\xC3', '\xA9', '\xAA', '|', '?', 'x', '*', '?'};
+
+    std::istringstream in(unicode_regex);
+    alegna::lexer::regex::regex_parser rp(in);
+    auto parsed = rp.parse_regex();
+    std::vector<char> actual;
+    if (parsed)
+        actual = parsed.value();
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
+MAKE_TEST(regex_parser_4, Tests if malformed regexes and Unicode classes containing regex operators are rejected)
+    std::vector<std::string> invalid = {"[\\u{28}-\\u{2A}]", "[\\u{20}-\\u{7E}]", "[\\u{0}]", "[\\u{3F}]",
+                                        "a|", "|a", "()", "(a|)", "*", "a(", "a)", "\n"};
+    std::vector<bool> expected(invalid.size(), true);
+    std::vector<bool> actual;
+    for (const auto& regex: invalid)
+    {
+        bool threw = false;
+        try
+        {
+            std::istringstream in(regex);
+            alegna::lexer::regex::regex_parser rp(in);
+            rp.parse_regex();
+        }
+        catch (const alegna::exceptions::invalid_regex_exception&)
+        {
+            threw = true;
+        }
+        actual.push_back(threw);
+    }
+    CONTENTS_TEST(expected, actual);
+    PASSED()
+END_TEST()
+
 int main(int argc, char** argv)
 {
+    test_regex_parser_1();
+    test_regex_parser_2();
+    test_regex_parser_3();
+    test_regex_parser_4();
     TEST_SUMMARY()
-    return 0;
+    return num_failed == 0 ? 0 : 1;
 }
\ No newline at end of file